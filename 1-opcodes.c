@@ -136,6 +136,8 @@ void swap_opcode(monty_program_t *program_ptr)
 	first = program_ptr->stack;
 	second = program_ptr->stack->next;
 	first->next = second->next;
+	if (first->next != NULL)
+		first->next->prev = first;
 	first->prev = second;
 	second->next = first;
 	second->prev = NULL;
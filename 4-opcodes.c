@@ -16,8 +16,52 @@ void stack_opcode(monty_program_t *program_ptr)
  * queue_opcode - sets the mode of the program to queue (FIFO)
  * @program_ptr: pointer to the monty_program_t struct
  *
- 
+ * Description: this function sets the mode of the program to queue, which
+ * means the program will operate in First In First Out (FIFO) mode.
+ */
 void queue_opcode(monty_program_t *program_ptr)
 {
 	program_ptr->mode = 1;
 }
+
+/**
+ * bad_push_opcode - reports a push with a missing or invalid argument
+ * @program_ptr: pointer to the monty_program_t struct
+ *
+ * Description: this function prints the push usage error for the current
+ * line and exits the program.
+ */
+void bad_push_opcode(monty_program_t *program_ptr)
+{
+	fprintf(stderr, "L%d: usage: push integer\n",
+		program_ptr->line_num);
+	exit(EXIT_FAILURE);
+}
+
+/**
+ * bad_data_opcode - reports a data directive with an invalid argument
+ * @program_ptr: pointer to the monty_program_t struct
+ *
+ * Description: this function prints the data usage error for the current
+ * line and exits the program.
+ */
+void bad_data_opcode(monty_program_t *program_ptr)
+{
+	fprintf(stderr, "L%d: usage: data hex|b64|file argument\n",
+		program_ptr->line_num);
+	exit(EXIT_FAILURE);
+}
+
+/**
+ * unknown_opcode - reports an unknown instruction
+ * @program_ptr: pointer to the monty_program_t struct
+ *
+ * Description: this function prints the unknown instruction error for the
+ * current line and exits the program.
+ */
+void unknown_opcode(monty_program_t *program_ptr)
+{
+	fprintf(stderr, "L%d: unknown instruction %s\n",
+		program_ptr->line_num, program_ptr->current_opcode);
+	exit(EXIT_FAILURE);
+}
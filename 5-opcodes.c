@@ -0,0 +1,89 @@
+#include "monty.h"
+
+/**
+ * channel_error - reports a send or recv that can't complete
+ * @program_ptr: pointer to the monty_program_t struct
+ * @opcode: "send" or "recv"
+ * @state: "full" or "empty"
+ *
+ * Description: when every script is blocked, all of them can find out at
+ * once. Only the first one to get here reports the error and ends the
+ * program; the others wait for it to do so.
+ */
+static void channel_error(monty_program_t *program_ptr, const char *opcode,
+	const char *state)
+{
+	static int failing;
+
+	if (__atomic_exchange_n(&failing, 1, __ATOMIC_SEQ_CST))
+	{
+		for (;;)
+			pause();
+	}
+	fprintf(stderr, "L%d: can't %s, channel %s %s\n",
+		program_ptr->line_num, opcode,
+		program_ptr->current_insn->channel->name, state);
+	exit(EXIT_FAILURE);
+}
+
+/**
+ * send_opcode - moves the top element of the stack to a channel
+ * @program_ptr: pointer to the monty_program_t struct
+ *
+ * Description: this function removes the top element of the stack and
+ * adds its value to the channel named on the line. If the stack is empty,
+ * it prints an error message and exits the program. If the channel is
+ * full, it waits for a consumer (see channel_transfer); if none can come,
+ * it prints an error message and exits.
+ */
+void send_opcode(monty_program_t *program_ptr)
+{
+	channel_t *channel = program_ptr->current_insn->channel;
+	int value;
+
+	if (program_ptr->stack == NULL)
+	{
+		fprintf(stderr, "L%d: can't send, stack empty\n",
+			program_ptr->line_num);
+		exit(EXIT_FAILURE);
+	}
+	value = program_ptr->stack->n;
+	if (!channel_transfer(channel, 1, &value))
+		channel_error(program_ptr, "send", "full");
+	pop_opcode(program_ptr);
+}
+
+/**
+ * recv_opcode - pushes a value taken from a channel
+ * @program_ptr: pointer to the monty_program_t struct
+ *
+ * Description: this function takes the oldest value of the channel named
+ * on the line and pushes it as push would in the current mode. If the
+ * channel is empty, it waits for a producer (see channel_transfer); if
+ * none can come, it prints an error message and exits.
+ */
+void recv_opcode(monty_program_t *program_ptr)
+{
+	channel_t *channel = program_ptr->current_insn->channel;
+	int value;
+	int32_t value32;
+
+	if (!channel_transfer(channel, 0, &value))
+		channel_error(program_ptr, "recv", "empty");
+	value32 = value;
+	push_values(program_ptr, &value32, 1);
+}
+
+/**
+ * bad_channel_opcode - reports a send or recv without a channel name
+ * @program_ptr: pointer to the monty_program_t struct
+ *
+ * Description: this function prints the channel usage error for the
+ * current line and exits the program.
+ */
+void bad_channel_opcode(monty_program_t *program_ptr)
+{
+	fprintf(stderr, "L%d: usage: send|recv channel\n",
+		program_ptr->line_num);
+	exit(EXIT_FAILURE);
+}
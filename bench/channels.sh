@@ -0,0 +1,66 @@
+#!/bin/sh
+# Measures channel throughput for pipelines of producer and consumer
+# scripts run with "monty -p".
+#
+# usage: bench/channels.sh [monty binary] [values per pipeline]
+#
+# Every producer loads its share of the values with one data directive
+# and sends them to channel "ch"; every consumer receives its share and
+# adds it up. The number of values is rounded down to a multiple of both
+# the number of producers and the number of consumers, so that every
+# value sent is received.
+#
+# Each pipeline is also run without channels: the producers pop their
+# values and the consumers push zeros, so the scripts have as many lines
+# to decode and run. The "base ms" column is that run, and values/s only
+# counts the time above it, spent moving values through the channel.
+
+MONTY=${1:-./monty}
+TOTAL=${2:-2000000}
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+script()
+{
+	# script <file> <first line> <repeated lines> <number of lines>
+	printf '%s\n' "$2" > "$1"
+	yes "$3" | head -n "$4" >> "$1"
+}
+
+run()
+{
+	# run <producer script> <consumer script>; prints the time in ms
+	FILES=""
+	i=0
+	while [ $i -lt "$P" ]; do FILES="$FILES $1"; i=$((i + 1)); done
+	i=0
+	while [ $i -lt "$C" ]; do FILES="$FILES $2"; i=$((i + 1)); done
+	START=$(date +%s%N)
+	"$MONTY" -p $FILES > /dev/null || exit 1
+	echo $(( ($(date +%s%N) - START) / 1000000 ))
+}
+
+printf '%-10s %-10s %12s %10s %10s %14s\n' producers consumers values ms \
+	"base ms" values/s
+for config in "1 1" "2 2" "4 4" "8 8" "1 4" "4 1"
+do
+	set -- $config
+	P=$1
+	C=$2
+	N=$((TOTAL / (P * C) * P * C))
+	[ "$N" -gt 0 ] || N=$((P * C))
+	SENT=$((N / P))
+	RECEIVED=$((N / C))
+	head -c $((SENT * 4)) /dev/zero > "$DIR/values.bin"
+	script "$DIR/producer.m" "data file $DIR/values.bin" "send ch" "$SENT"
+	script "$DIR/consumer.m" "push 0" "recv ch
+add" $((RECEIVED * 2))
+	script "$DIR/producer0.m" "data file $DIR/values.bin" "pop" "$SENT"
+	script "$DIR/consumer0.m" "push 0" "push 0
+add" $((RECEIVED * 2))
+	MS=$(run "$DIR/producer.m" "$DIR/consumer.m") || exit 1
+	BASE=$(run "$DIR/producer0.m" "$DIR/consumer0.m") || exit 1
+	NET=$((MS - BASE))
+	printf '%-10s %-10s %12s %10s %10s %14s\n' "$P" "$C" "$N" "$MS" \
+		"$BASE" $((N * 1000 / (NET > 0 ? NET : 1)))
+done
@@ -0,0 +1,76 @@
+#!/bin/sh
+# Measures how fast straight-line scripts are decoded and run.
+#
+# usage: bench/straight.sh [monty binary] [baseline binary] [lines]
+#
+# Three scripts are generated: arithmetic (push, add, sub, mul, swap and
+# div or mod by a pushed constant, the stack staying shallow), pushes only
+# and push/pop pairs. Each one runs five times per binary and the fastest
+# run is reported. Give a baseline binary, for example a build of an
+# earlier commit, to show its time in the "base ms" column.
+
+MONTY=${1:-./monty}
+BASELINE=$2
+LINES=${3:-2000000}
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+best()
+{
+	# best <binary> <script>; prints the fastest of five runs in ms
+	BEST=""
+	for run in 1 2 3 4 5
+	do
+		START=$(date +%s%N)
+		"$1" "$2" > /dev/null || exit 1
+		MS=$(( ($(date +%s%N) - START) / 1000000 ))
+		if [ -z "$BEST" ] || [ "$MS" -lt "$BEST" ]; then BEST=$MS; fi
+	done
+	echo "$BEST"
+}
+
+awk -v n="$LINES" 'BEGIN {
+	srand(1)
+	print "push 1"
+	print "push 2"
+	d = 2
+	for (i = 2; i < n; i++) {
+		r = rand()
+		if (d < 2 || (r < 0.45 && d < 50)) {
+			print "push " int(rand() * 199) - 99
+			d++
+		} else if (r < 0.6) {
+			print "add"
+			d--
+		} else if (r < 0.7) {
+			print "mul"
+			d--
+		} else if (r < 0.8) {
+			print "sub"
+			d--
+		} else if (r < 0.9 && i + 1 < n) {
+			print "push " int(rand() * 9) + 1
+			print (r < 0.85 ? "div" : "mod")
+			i++
+		} else
+			print "swap"
+	}
+}' > "$DIR/arith.m"
+awk -v n="$LINES" 'BEGIN { for (i = 0; i < n; i++) print "push " i % 1000 }' \
+	> "$DIR/push.m"
+awk -v n="$LINES" 'BEGIN {
+	for (i = 0; i < n; i += 2) { print "push " i % 1000; print "pop" }
+}' > "$DIR/pushpop.m"
+
+printf '%-10s %10s %10s %10s %14s\n' script lines ms "base ms" lines/s
+for name in arith push pushpop
+do
+	MS=$(best "$MONTY" "$DIR/$name.m") || exit 1
+	BASE=-
+	if [ -n "$BASELINE" ]
+	then
+		BASE=$(best "$BASELINE" "$DIR/$name.m") || exit 1
+	fi
+	printf '%-10s %10s %10s %10s %14s\n' "$name" "$LINES" "$MS" "$BASE" \
+		$((LINES * 1000 / (MS > 0 ? MS : 1)))
+done
@@ -0,0 +1,174 @@
+#include "monty.h"
+
+size_t channel_capacity = CHANNEL_CAPACITY;
+int channel_blocking = 1;
+unsigned int live_contexts = 1;
+
+static channel_t *channels;
+static pthread_mutex_t channels_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * new_channel - allocates an empty channel
+ * @name: channel name
+ *
+ * Description: the capacity is channel_capacity rounded up to a power of
+ * two, and at least two. Slot i starts with sequence number i, free for
+ * the producer that claims position i.
+ *
+ * Return: the new channel
+ */
+static channel_t *new_channel(const char *name)
+{
+	channel_t *channel;
+	size_t capacity = 2, i;
+
+	while (capacity < channel_capacity)
+		capacity <<= 1;
+	channel = malloc(sizeof(channel_t));
+	if (channel != NULL)
+		channel->name = malloc(strlen(name) + 1);
+	if (channel != NULL && channel->name != NULL)
+		channel->cells = malloc(sizeof(channel_cell_t) * capacity);
+	if (channel == NULL || channel->name == NULL || channel->cells == NULL)
+	{
+		fprintf(stderr, "Error: malloc failed\n");
+		exit(EXIT_FAILURE);
+	}
+	strcpy(channel->name, name);
+	channel->mask = capacity - 1;
+	for (i = 0; i < capacity; i++)
+		channel->cells[i].seq = i;
+	channel->enqueue_pos = 0;
+	channel->dequeue_pos = 0;
+	pthread_mutex_init(&channel->wait_lock, NULL);
+	pthread_cond_init(&channel->wait_cond, NULL);
+	channel->parked = 0;
+	return (channel);
+}
+
+/**
+ * parse_channel - resolves the channel named by send or recv
+ * @insn: instruction being decoded
+ * @saveptr: strtok_r state of the line being decoded
+ *
+ * Description: channels are created the first time any script names them
+ * and live until free_channels. Scripts decode concurrently, so the
+ * registry is locked; the lookup happens once per line, when it is
+ * loaded, never when it runs. A missing name turns the instruction into
+ * OP_BAD_CHANNEL.
+ */
+void parse_channel(insn_t *insn, char **saveptr)
+{
+	char *name = strtok_r(NULL, " \n\t", saveptr);
+	channel_t *channel;
+
+	if (name == NULL)
+	{
+		insn->op = OP_BAD_CHANNEL;
+		return;
+	}
+	pthread_mutex_lock(&channels_lock);
+	for (channel = channels; channel != NULL; channel = channel->next)
+	{
+		if (strcmp(channel->name, name) == 0)
+			break;
+	}
+	if (channel == NULL)
+	{
+		channel = new_channel(name);
+		channel->next = channels;
+		channels = channel;
+	}
+	pthread_mutex_unlock(&channels_lock);
+	insn->channel = channel;
+}
+
+/**
+ * channel_push - adds a value to a channel without blocking
+ * @channel: channel
+ * @value: value to add
+ *
+ * Return: 1 on success, 0 if the channel is full
+ */
+int channel_push(channel_t *channel, int value)
+{
+	channel_cell_t *cell;
+	size_t pos, seq;
+	long dif;
+
+	pos = __atomic_load_n(&channel->enqueue_pos, __ATOMIC_RELAXED);
+	for (;;)
+	{
+		cell = &channel->cells[pos & channel->mask];
+		seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+		dif = (long)seq - (long)pos;
+		if (dif == 0 && __atomic_compare_exchange_n(&channel->enqueue_pos,
+			&pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			break;
+		if (dif < 0)
+			return (0);
+		if (dif > 0)
+			pos = __atomic_load_n(&channel->enqueue_pos,
+				__ATOMIC_RELAXED);
+	}
+	cell->value = value;
+	__atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+	channel_progress(channel);
+	return (1);
+}
+
+/**
+ * channel_pop - takes a value from a channel without blocking
+ * @channel: channel
+ * @value: set to the value taken
+ *
+ * Return: 1 on success, 0 if the channel is empty
+ */
+int channel_pop(channel_t *channel, int *value)
+{
+	channel_cell_t *cell;
+	size_t pos, seq;
+	long dif;
+
+	pos = __atomic_load_n(&channel->dequeue_pos, __ATOMIC_RELAXED);
+	for (;;)
+	{
+		cell = &channel->cells[pos & channel->mask];
+		seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+		dif = (long)seq - (long)(pos + 1);
+		if (dif == 0 && __atomic_compare_exchange_n(&channel->dequeue_pos,
+			&pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			break;
+		if (dif < 0)
+			return (0);
+		if (dif > 0)
+			pos = __atomic_load_n(&channel->dequeue_pos,
+				__ATOMIC_RELAXED);
+	}
+	*value = cell->value;
+	__atomic_store_n(&cell->seq, pos + channel->mask + 1,
+		__ATOMIC_RELEASE);
+	channel_progress(channel);
+	return (1);
+}
+
+/**
+ * free_channels - frees every channel
+ *
+ * Description: must only be called once no script is running.
+ */
+void free_channels(void)
+{
+	channel_t *channel;
+
+	while (channels != NULL)
+	{
+		channel = channels;
+		channels = channel->next;
+		pthread_mutex_destroy(&channel->wait_lock);
+		pthread_cond_destroy(&channel->wait_cond);
+		free(channel->name);
+		free(channel->cells);
+		free(channel);
+	}
+}
@@ -1,111 +1,215 @@
 #include "monty.h"
 
 /**
- * parse_line - parses a line of Monty bytecode and updates program state
+ * next_token - splits the next token off a line
+ * @saveptr: where the previous token ended, updated past this one
+ *
+ * Description: a cut-down strtok_r for the " \n\t" separators that
+ * leaves *saveptr where strtok_r would, so parse_data and parse_channel
+ * can carry on with strtok_r.
+ *
+ * Return: the token, or NULL if the line has no more tokens
+ */
+static char *next_token(char **saveptr)
+{
+	char *s = *saveptr, *token;
+
+	while (*s == ' ' || *s == '\n' || *s == '\t')
+		s++;
+	if (*s == '\0')
+	{
+		*saveptr = s;
+		return (NULL);
+	}
+	token = s;
+	while (*s != '\0' && *s != ' ' && *s != '\n' && *s != '\t')
+		s++;
+	if (*s != '\0')
+		*s++ = '\0';
+	*saveptr = s;
+	return (token);
+}
+
+/**
+ * parse_int - converts the argument of push
+ * @token: argument text
+ * @value: set to the value
+ *
+ * Description: an optional sign and up to nine digits, the common case,
+ * are converted inline; anything else goes through strtol, so the result
+ * is always what strtol would give.
+ *
+ * Return: 1 if the whole token is an integer, 0 otherwise
+ */
+static int parse_int(const char *token, int *value)
+{
+	const char *s = token + (*token == '-' || *token == '+');
+	char *endptr;
+	int n = 0, i;
+
+	for (i = 0; i < 9 && s[i] >= '0' && s[i] <= '9'; i++)
+		n = n * 10 + (s[i] - '0');
+	if (i > 0 && s[i] == '\0')
+	{
+		*value = *token == '-' ? -n : n;
+		return (1);
+	}
+	*value = (int)strtol(token, &endptr, 10);
+	return (*endptr == '\0' && token != endptr);
+}
+
+/**
+ * parse_line - parses a line of Monty bytecode into a decoded instruction
  * @program_ptr: Pointer to the monty_program_t struct
+ * @insn: instruction to fill in
  *
  * Description: this function takes a line from the Monty bytecode file,
- * extracts the opcode and its argument (if present), and updates the
- * program's state accordingly. If an error is found (e.g., invalid integer),
- * the function will print an error message and exit the program.
+ * extracts the opcode and its argument (if present), and stores them in
+ * @insn. Empty lines and comments leave the opcode NULL. A push with an
+ * invalid integer decodes to OP_BAD_PUSH so the error is reported when the
+ * line is reached rather than while the script is loaded. The arguments of
+ * data are decoded by parse_data and channel names by parse_channel.
  */
-void parse_line(monty_program_t *program_ptr)
+void parse_line(monty_program_t *program_ptr, insn_t *insn)
 {
 	char *token;
-	char *endptr;
-	long arg;
+	char *saveptr;
 	char *line;
 
+	program_ptr->current_opcode = NULL;
 	line = program_ptr->current_line;
 	while (*line == ' ')
 	{
 		line++;
 	}
 	if (*line == '#' || *line == '\0')
-	{
-		program_ptr->current_opcode = NULL;
 		return;
-	}
-	token = strtok(program_ptr->current_line, " \n\t");
+	saveptr = line;
+	token = next_token(&saveptr);
 	if (token == NULL)
-	{
-		program_ptr->current_opcode = NULL;
 		return;
-	}
 	program_ptr->current_opcode = token;
-	if (strcmp(program_ptr->current_opcode, "push") == 0)
+	insn->op = lookup_opcode(token);
+	insn->arg = 0;
+	insn->line_num = program_ptr->line_num;
+	insn->text = NULL;
+	insn->data = NULL;
+	insn->channel = NULL;
+	insn->block = NULL;
+	if (insn->op == OP_UNKNOWN)
 	{
-		token = strtok(NULL, " \n\t");
-		if (token == NULL)
-		{
-			fprintf(stderr, "L%d: usage: push integer\n",
-				program_ptr->line_num);
-			exit(EXIT_FAILURE);
-		}
-		arg = strtol(token, &endptr, 10);
-		if (*endptr != '\0' || token == endptr)
+		insn->text = malloc(strlen(token) + 1);
+		if (insn->text == NULL)
 		{
-			fprintf(stderr, "L%d: usage: push integer\n",
-				program_ptr->line_num);
+			fprintf(stderr, "Error: malloc failed\n");
 			exit(EXIT_FAILURE);
 		}
-		program_ptr->current_arg = (int)arg;
+		strcpy(insn->text, token);
+	}
+	else if (insn->op == OP_PUSH)
+	{
+		token = next_token(&saveptr);
+		if (token == NULL || !parse_int(token, &insn->arg))
+			insn->op = OP_BAD_PUSH;
 	}
+	else if (insn->op == OP_DATA)
+		parse_data(insn, &saveptr);
+	else if (insn->op == OP_SEND || insn->op == OP_RECV)
+		parse_channel(insn, &saveptr);
 }
 
+static const char * const opcode_names[OP_COUNT] = {
+	"push", "pall", "pint", "pop", "swap", "add", "nop", "sub", "div",
+	"mul", "mod", "pchar", "pstr", "rotl", "rotr", "stack", "queue",
+	"data", "send", "recv", NULL, NULL, NULL, NULL, NULL
+};
+
+static void (* const opcode_handlers[OP_COUNT])(monty_program_t *) = {
+	push_opcode, pall_opcode, pint_opcode, pop_opcode, swap_opcode,
+	add_opcode, nop_opcode, sub_opcode, div_opcode, mul_opcode,
+	mod_opcode, pchar_opcode, pstr_opcode, rotl_opcode, rotr_opcode,
+	stack_opcode, queue_opcode, data_opcode, send_opcode, recv_opcode,
+	push_queue_opcode, bad_push_opcode, bad_data_opcode, bad_channel_opcode,
+	unknown_opcode
+};
+
 /**
- * execute_opcode - executes the current opcode
- * @program_ptr: pointer to the monty_program_t struct
- * Description: this function checks the current opcode and executes the
- * corresponding function. If the opcode is NULL (indicating an empty line or
- * just whitespace), or if the opcode is unknown, it handles these cases
- * appropriately, including exiting the program with an error message if
- * an unknown instruction is encountered.
+ * lookup_opcode - resolves an opcode name
+ * @opcode: opcode text
+ *
+ * Description: the first letter picks the few opcodes that can match,
+ * most frequent first, so a name is compared with at most six others.
+ *
+ * Return: the matching opcode, or OP_UNKNOWN
  */
-void execute_opcode(monty_program_t *program_ptr)
+opcode_t lookup_opcode(const char *opcode)
 {
-	if (program_ptr->current_opcode == NULL)
-		return;
-	if (strcmp(program_ptr->current_opcode, "push") == 0)
-		push_opcode(program_ptr);
-	else if (strcmp(program_ptr->current_opcode, "pall") == 0)
-		pall_opcode(program_ptr);
-	else if (strcmp(program_ptr->current_opcode, "pint") == 0)
-		pint_opcode(program_ptr);
-	else if (strcmp(program_ptr->current_opcode, "pop") == 0)
-		pop_opcode(program_ptr);
-	else if (strcmp(program_ptr->current_opcode, "swap") == 0)
-		swap_opcode(program_ptr);
-	else if (strcmp(program_ptr->current_opcode, "add") == 0)
-		add_opcode(program_ptr);
-	else if (strcmp(program_ptr->current_opcode, "nop") == 0)
-		nop_opcode(program_ptr);
-	else if (strcmp(program_ptr->current_opcode, "sub") == 0)
-		sub_opcode(program_ptr);
-	else if (strcmp(program_ptr->current_opcode, "div") == 0)
-		div_opcode(program_ptr);
-	else if (strcmp(program_ptr->current_opcode, "mul") == 0)
-		mul_opcode(program_ptr);
-	else if (strcmp(program_ptr->current_opcode, "mod") == 0)
-		mod_opcode(program_ptr);
-	else if (strcmp(program_ptr->current_opcode, "pchar") == 0)
-		pchar_opcode(program_ptr);
-	else if (strcmp(program_ptr->current_opcode, "pstr") == 0)
-		pstr_opcode(program_ptr);
-	else if (strcmp(program_ptr->current_opcode, "rotl") == 0)
-		rotl_opcode(program_ptr);
-	else if (strcmp(program_ptr->current_opcode, "rotr") == 0)
-		rotr_opcode(program_ptr);
-	else if (strcmp(program_ptr->current_opcode, "stack") == 0)
-		stack_opcode(program_ptr);
-	else if (strcmp(program_ptr->current_opcode, "queue") == 0)
-		queue_opcode(program_ptr);
-	else
+	static const opcode_t by_a[] = {OP_ADD, OP_UNKNOWN};
+	static const opcode_t by_d[] = {OP_DIV, OP_DATA, OP_UNKNOWN};
+	static const opcode_t by_m[] = {OP_MUL, OP_MOD, OP_UNKNOWN};
+	static const opcode_t by_n[] = {OP_NOP, OP_UNKNOWN};
+	static const opcode_t by_p[] = {OP_PUSH, OP_POP, OP_PALL, OP_PINT,
+		OP_PCHAR, OP_PSTR, OP_UNKNOWN};
+	static const opcode_t by_q[] = {OP_QUEUE, OP_UNKNOWN};
+	static const opcode_t by_r[] = {OP_ROTL, OP_ROTR, OP_RECV, OP_UNKNOWN};
+	static const opcode_t by_s[] = {OP_SWAP, OP_SUB, OP_SEND, OP_STACK,
+		OP_UNKNOWN};
+	static const opcode_t none[] = {OP_UNKNOWN};
+	const opcode_t *op;
+
+	switch (opcode[0])
+	{
+	case 'a':
+		op = by_a;
+		break;
+	case 'd':
+		op = by_d;
+		break;
+	case 'm':
+		op = by_m;
+		break;
+	case 'n':
+		op = by_n;
+		break;
+	case 'p':
+		op = by_p;
+		break;
+	case 'q':
+		op = by_q;
+		break;
+	case 'r':
+		op = by_r;
+		break;
+	case 's':
+		op = by_s;
+		break;
+	default:
+		op = none;
+	}
+	for (; *op != OP_UNKNOWN; op++)
 	{
-		fprintf(stderr, "L%d: unknown instruction %s\n",
-			program_ptr->line_num, program_ptr->current_opcode);
-		exit(EXIT_FAILURE);
+		if (strcmp(opcode_names[*op], opcode) == 0)
+			return (*op);
 	}
+	return (OP_UNKNOWN);
+}
+
+/**
+ * execute_opcode - executes a decoded instruction
+ * @program_ptr: pointer to the monty_program_t struct
+ * @insn: instruction to execute
+ *
+ * Description: this function loads the instruction's line number and
+ * argument into the program state and calls the handler for its opcode.
+ * Error opcodes have handlers that print the message and exit.
+ */
+void execute_opcode(monty_program_t *program_ptr, insn_t *insn)
+{
+	program_ptr->line_num = insn->line_num;
+	program_ptr->current_arg = insn->arg;
+	program_ptr->current_opcode = insn->text;
+	program_ptr->current_insn = insn;
+	opcode_handlers[insn->op](program_ptr);
 }
 
 /**
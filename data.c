@@ -0,0 +1,214 @@
+#include "monty.h"
+
+/**
+ * decode_hex - decodes an inline hex blob into integers
+ * @blob: hex digits, eight per integer, most significant digit first
+ * @insn: instruction receiving the values and their count
+ *
+ * Return: 1 on success, 0 if the blob is malformed
+ */
+static int decode_hex(const char *blob, insn_t *insn)
+{
+	static const char digits[] = "0123456789abcdef";
+	size_t len = strlen(blob), i;
+	uint32_t word = 0;
+
+	if (len % 8 != 0)
+		return (0);
+	insn->data = malloc(len / 2);
+	if (insn->data == NULL)
+	{
+		fprintf(stderr, "Error: malloc failed\n");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0; i < len; i++)
+	{
+		if (!isxdigit((unsigned char)blob[i]))
+			return (0);
+		word = word << 4 |
+			(uint32_t)(strchr(digits, tolower(blob[i])) - digits);
+		if (i % 8 == 7)
+			insn->data[i / 8] = (int32_t)word;
+	}
+	insn->arg = (int)(len / 8);
+	return (1);
+}
+
+/**
+ * decode_b64 - decodes an inline base64 blob into integers
+ * @blob: base64 text of raw int32 values in host byte order
+ * @insn: instruction receiving the values and their count
+ *
+ * Description: padding is optional, but when present it must complete
+ * the last group of four characters. A group of a single character can't
+ * encode a byte and is rejected.
+ *
+ * Return: 1 on success, 0 if the blob is malformed
+ */
+static int decode_b64(const char *blob, insn_t *insn)
+{
+	static const char alphabet[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	size_t len = strlen(blob), i, n = 0;
+	unsigned char *bytes;
+	uint32_t bits = 0;
+	const char *pos;
+
+	bytes = malloc(len / 4 * 3 + 4);
+	if (bytes == NULL)
+	{
+		fprintf(stderr, "Error: malloc failed\n");
+		exit(EXIT_FAILURE);
+	}
+	insn->data = (int32_t *)bytes;
+	for (i = 0; i < len && blob[i] != '='; i++)
+	{
+		pos = strchr(alphabet, blob[i]);
+		if (pos == NULL)
+			return (0);
+		bits = bits << 6 | (uint32_t)(pos - alphabet);
+		if (i % 4 != 0)
+			bytes[n++] = (unsigned char)(bits >> (6 - 2 * (i % 4)));
+	}
+	if (i % 4 == 1 || (i < len && len - i != (4 - i % 4) % 4) ||
+		strspn(blob + i, "=") != len - i || n % 4 != 0)
+		return (0);
+	insn->arg = (int)(n / 4);
+	return (1);
+}
+
+/**
+ * parse_data - decodes the arguments of a data directive
+ * @insn: instruction being decoded
+ * @saveptr: strtok_r state of the line being decoded
+ *
+ * Description: "data hex <blob>" and "data b64 <blob>" are decoded once,
+ * while the script is loaded. "data file <path>" only keeps the path; the
+ * file is mapped when the line runs. Malformed arguments turn the
+ * instruction into OP_BAD_DATA.
+ */
+void parse_data(insn_t *insn, char **saveptr)
+{
+	char *kind, *blob;
+	int ok = 0;
+
+	kind = strtok_r(NULL, " \n\t", saveptr);
+	blob = strtok_r(NULL, " \n\t", saveptr);
+	if (kind != NULL && blob != NULL && strcmp(kind, "file") == 0)
+	{
+		insn->text = malloc(strlen(blob) + 1);
+		if (insn->text == NULL)
+		{
+			fprintf(stderr, "Error: malloc failed\n");
+			exit(EXIT_FAILURE);
+		}
+		strcpy(insn->text, blob);
+		return;
+	}
+	if (kind != NULL && blob != NULL && strcmp(kind, "hex") == 0)
+		ok = decode_hex(blob, insn);
+	else if (kind != NULL && blob != NULL && strcmp(kind, "b64") == 0)
+		ok = decode_b64(blob, insn);
+	if (!ok)
+		insn->op = OP_BAD_DATA;
+}
+
+/**
+ * push_values - pushes a block of integers in one operation
+ * @program_ptr: pointer to the monty_program_t struct
+ * @values: integers to push, in the order repeated push opcodes would
+ * push them
+ * @count: number of integers
+ *
+ * Description: the new nodes are linked into a chain first and the chain
+ * is spliced into the stack once. In stack mode the last value ends up on
+ * top; in queue mode the values are appended in order after the queue
+ * tail, which is then cached like push_queue_opcode does, so a run of
+ * them never walks the queue again.
+ */
+void push_values(monty_program_t *program_ptr, const int32_t *values,
+	size_t count)
+{
+	stack_t *first = NULL, *last = NULL, *node;
+	size_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		node = malloc(sizeof(stack_t));
+		if (node == NULL)
+		{
+			fprintf(stderr, "Error: malloc failed\n");
+			exit(EXIT_FAILURE);
+		}
+		node->n = program_ptr->mode == MODE_STACK ?
+			values[count - 1 - i] : values[i];
+		node->prev = last;
+		node->next = NULL;
+		if (last != NULL)
+			last->next = node;
+		else
+			first = node;
+		last = node;
+	}
+	if (first == NULL)
+		return;
+	if (program_ptr->mode == MODE_STACK)
+	{
+		last->next = program_ptr->stack;
+		if (program_ptr->stack != NULL)
+			program_ptr->stack->prev = last;
+		program_ptr->stack = first;
+		return;
+	}
+	node = queue_tail(program_ptr);
+	first->prev = node;
+	if (node == NULL)
+		program_ptr->stack = first;
+	else
+		node->next = first;
+	program_ptr->tail = last;
+}
+
+/**
+ * data_opcode - pushes the integers of a data directive
+ * @program_ptr: pointer to the monty_program_t struct
+ *
+ * Description: inline values were decoded when the script was loaded. An
+ * external file holds raw int32 values in host byte order; it is mapped
+ * read-only and its values are pushed straight from the mapping. If the
+ * file can't be opened or its size is not a multiple of four bytes, an
+ * error message is printed and the program exits.
+ */
+void data_opcode(monty_program_t *program_ptr)
+{
+	insn_t *insn = program_ptr->current_insn;
+	struct stat st;
+	void *map = MAP_FAILED;
+	int fd;
+
+	if (insn->text == NULL)
+	{
+		push_values(program_ptr, insn->data, (size_t)insn->arg);
+		return;
+	}
+	fd = open(insn->text, O_RDONLY);
+	if (fd != -1 && fstat(fd, &st) == 0 && st.st_size % 4 == 0)
+	{
+		if (st.st_size == 0)
+		{
+			close(fd);
+			return;
+		}
+		map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	if (map == MAP_FAILED)
+	{
+		fprintf(stderr, "L%d: can't load data file %s\n",
+			program_ptr->line_num, insn->text);
+		exit(EXIT_FAILURE);
+	}
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+	push_values(program_ptr, map, st.st_size / 4);
+	munmap(map, st.st_size);
+	close(fd);
+}
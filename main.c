@@ -1,43 +1,151 @@
 #include "monty.h"
 
 /**
- * main - entry point for the Monty bytecode interpreter
- * @argc: argument count
- * @argv: argument vector
+ * open_script - initialises a program and opens its script
+ * @program_ptr: pointer to the monty_program_t struct
+ * @path: path of the Monty bytecode file
  *
- * Return: (0) on success, exits with EXIT_FAILURE on error
+ * Description: if the file can't be opened, this function prints an
+ * error message and exits the program.
  */
-int main(int argc, char **argv)
+static void open_script(monty_program_t *program_ptr, const char *path)
 {
-	monty_program_t program = {NULL};
-	monty_program_t *program_ptr = &program;
-	char line[1024];
-
 	program_ptr->stack = NULL;
 	program_ptr->line_num = 0;
+	program_ptr->lines_read = 0;
 	program_ptr->mode = 0;
+	program_ptr->tail = NULL;
+	program_ptr->quick_hits = 0;
+	program_ptr->line_buf = NULL;
+	program_ptr->line_size = 0;
 	program_ptr->current_line = NULL;
 	program_ptr->current_opcode = NULL;
-	if (argc != 2)
+	program_ptr->current_insn = NULL;
+	program_ptr->code = NULL;
+	program_ptr->code_len = 0;
+	program_ptr->script_file = fopen(path, "r");
+	if (program_ptr->script_file == NULL)
+	{
+		fprintf(stderr, "Error: Can't open file %s\n", path);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/**
+ * parse_options - parses the options of pipeline mode
+ * @argc: argument count
+ * @argv: argument vector
+ *
+ * Description: "-p" runs every file given in its own interpreter thread,
+ * "-c capacity" sets the capacity of channels (1 to CHANNEL_CAPACITY_MAX)
+ * and "-f" makes send and recv fail instead of waiting on a full or empty
+ * channel. On a usage error, including a capacity with trailing garbage
+ * or out of range, this function prints the usage message and exits the
+ * program.
+ *
+ * Return: index in argv of the first file
+ */
+static int parse_options(int argc, char **argv)
+{
+	int opt, pipeline = 0;
+	long capacity;
+	char *endptr;
+
+	opterr = 0;
+	while ((opt = getopt(argc, argv, "pc:f")) != -1)
+	{
+		if (opt == 'p')
+			pipeline = 1;
+		else if (opt == 'f')
+			channel_blocking = 0;
+		else if (opt == 'c')
+		{
+			capacity = strtol(optarg, &endptr, 10);
+			if (*endptr != '\0' || endptr == optarg || capacity <= 0 ||
+				(unsigned long)capacity > CHANNEL_CAPACITY_MAX)
+				pipeline = -1;
+			channel_capacity = (size_t)capacity;
+		}
+		else
+			pipeline = -1;
+	}
+	if (pipeline != 1 || optind >= argc)
 	{
 		fprintf(stderr, "USAGE: monty file\n");
 		exit(EXIT_FAILURE);
 	}
-	program_ptr->script_file = fopen(argv[1], "r");
-	if (program_ptr->script_file == NULL)
+	return (optind);
+}
+
+/**
+ * run_pipeline - runs several scripts concurrently
+ * @argc: argument count
+ * @argv: argument vector
+ *
+ * Description: every script gets its own interpreter context (stack,
+ * mode and decoded program) and its own thread. Scripts only share the
+ * channels used by send and recv. An error in any script ends the whole
+ * process, as it would end a single script.
+ */
+static void run_pipeline(int argc, char **argv)
+{
+	monty_program_t *programs;
+	pthread_t *threads;
+	int first = parse_options(argc, argv), count = argc - first, i;
+
+	programs = malloc(sizeof(monty_program_t) * count);
+	threads = malloc(sizeof(pthread_t) * count);
+	if (programs == NULL || threads == NULL)
 	{
-		fprintf(stderr, "Error: Can't open file %s\n", argv[1]);
+		fprintf(stderr, "Error: malloc failed\n");
 		exit(EXIT_FAILURE);
 	}
-	while (fgets(line, sizeof(line), program_ptr->script_file))
+	for (i = 0; i < count; i++)
+		open_script(&programs[i], argv[first + i]);
+	live_contexts = count;
+	for (i = 0; i < count; i++)
 	{
-		program_ptr->line_num++;
-		program_ptr->current_line = line;
-		parse_line(program_ptr);
-		execute_opcode(program_ptr);
+		if (pthread_create(&threads[i], NULL, run_script, &programs[i]))
+		{
+			fprintf(stderr, "Error: can't start script %s\n",
+				argv[first + i]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	for (i = 0; i < count; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
+	free(programs);
+}
+
+/**
+ * main - entry point for the Monty bytecode interpreter
+ * @argc: argument count
+ * @argv: argument vector
+ *
+ * Description: "monty file" runs one script. "monty -p [-c capacity] [-f]
+ * file..." runs a pipeline of scripts connected by channels.
+ *
+ * Return: (0) on success, exits with EXIT_FAILURE on error
+ */
+int main(int argc, char **argv)
+{
+	monty_program_t program = {NULL};
+	monty_program_t *program_ptr = &program;
+
+	if (argc == 2)
+	{
+		open_script(program_ptr, argv[1]);
+		run_script(program_ptr);
+	}
+	else if (argc > 2)
+		run_pipeline(argc, argv);
+	else
+	{
+		fprintf(stderr, "USAGE: monty file\n");
+		exit(EXIT_FAILURE);
 	}
-	fclose(program_ptr->script_file);
-	free_stack(program_ptr->stack);
+	free_channels();
 
 	return (0);
 }
@@ -1,11 +1,28 @@
 #ifndef MONTY_H
 #define MONTY_H
 
+#define _DEFAULT_SOURCE
+
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <ctype.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#define PROGRAM_CHUNK 4096
+#define CHANNEL_CAPACITY 1024
+#define CHANNEL_CAPACITY_MAX (1UL << 24)
+#define CACHE_LINE 64
+#define WAIT_SPINS 64
+#define WAIT_PARK_NS 10000000L
 
 /* Data Structures */
 /**
@@ -51,15 +68,229 @@ typedef enum
 	MODE_QUEUE
 } stack_mode_t;
 
+/**
+ * enum opcode_e - decoded opcode identifiers
+ * @OP_PUSH: push
+ * @OP_PALL: pall
+ * @OP_PINT: pint
+ * @OP_POP: pop
+ * @OP_SWAP: swap
+ * @OP_ADD: add
+ * @OP_NOP: nop
+ * @OP_SUB: sub
+ * @OP_DIV: div
+ * @OP_MUL: mul
+ * @OP_MOD: mod
+ * @OP_PCHAR: pchar
+ * @OP_PSTR: pstr
+ * @OP_ROTL: rotl
+ * @OP_ROTR: rotr
+ * @OP_STACK: stack
+ * @OP_QUEUE: queue
+ * @OP_DATA: data, pushes a block of integers
+ * @OP_SEND: send, moves the top element to a channel
+ * @OP_RECV: recv, pushes a value taken from a channel
+ * @OP_PUSH_QUEUE: push quickened for queue mode
+ * @OP_BAD_PUSH: push with a missing or malformed argument
+ * @OP_BAD_DATA: data with a missing or malformed argument
+ * @OP_BAD_CHANNEL: send or recv without a channel name
+ * @OP_UNKNOWN: unknown instruction
+ * @OP_COUNT: number of opcodes
+ *
+ * Description: opcodes are resolved once when the script is loaded so
+ * the execution loop dispatches on an integer instead of comparing
+ * strings. Malformed lines decode to error opcodes that report the
+ * problem when they are reached, as the line by line interpreter did.
+ */
+typedef enum opcode_e
+{
+	OP_PUSH,
+	OP_PALL,
+	OP_PINT,
+	OP_POP,
+	OP_SWAP,
+	OP_ADD,
+	OP_NOP,
+	OP_SUB,
+	OP_DIV,
+	OP_MUL,
+	OP_MOD,
+	OP_PCHAR,
+	OP_PSTR,
+	OP_ROTL,
+	OP_ROTR,
+	OP_STACK,
+	OP_QUEUE,
+	OP_DATA,
+	OP_SEND,
+	OP_RECV,
+	OP_PUSH_QUEUE,
+	OP_BAD_PUSH,
+	OP_BAD_DATA,
+	OP_BAD_CHANNEL,
+	OP_UNKNOWN,
+	OP_COUNT
+} opcode_t;
+
+/**
+ * enum ir_op_e - register IR operations
+ * @IR_CONST: dst = a (immediate)
+ * @IR_ADD: dst = a + b
+ * @IR_SUB: dst = a - b
+ * @IR_MUL: dst = a * b
+ * @IR_DIV: dst = a / b, fails when b is zero
+ * @IR_MOD: dst = a % b, fails when b is zero
+ * @IR_DIVI: dst = a / b, b being a nonzero immediate
+ * @IR_MODI: dst = a % b, b being a nonzero immediate
+ */
+typedef enum ir_op_e
+{
+	IR_CONST,
+	IR_ADD,
+	IR_SUB,
+	IR_MUL,
+	IR_DIV,
+	IR_MOD,
+	IR_DIVI,
+	IR_MODI
+} ir_op_t;
+
+/**
+ * struct ir_insn_s - one register IR instruction
+ * @op: operation
+ * @a: first operand register (immediate value for IR_CONST)
+ * @b: second operand register (immediate value for IR_DIVI and IR_MODI)
+ * @line_num: script line the instruction came from, for error messages
+ *
+ * Description: IR instruction i of a block writes register i, and no
+ * other instruction of the block writes it.
+ */
+typedef struct ir_insn_s
+{
+	ir_op_t op;
+	int a;
+	int b;
+	unsigned int line_num;
+} ir_insn_t;
+
+/**
+ * struct ir_block_s - straight-line block translated to register IR
+ * @len: number of decoded instructions the block replaces
+ * @n_in: stack elements read on entry, held in registers -1 to -n_in
+ * (register -1 is the top of the stack)
+ * @code: IR instructions
+ * @n_code: number of IR instructions
+ * @out: registers left on the stack on exit, from bottom to top
+ * @n_out: number of registers in @out
+ * @n_quick: number of IR instructions specialised on an immediate operand
+ *
+ * Description: a block covers a run of push, pop, swap, nop and
+ * arithmetic opcodes executed in stack mode. Its net effect on the
+ * stack is to replace the top n_in elements with the n_out registers.
+ */
+typedef struct ir_block_s
+{
+	unsigned int len;
+	int n_in;
+	ir_insn_t *code;
+	int n_code;
+	int *out;
+	int n_out;
+	int n_quick;
+} ir_block_t;
+
+/**
+ * struct channel_cell_s - slot of a channel's ring buffer
+ * @seq: sequence number telling producers and consumers whose turn it is
+ * @value: value stored in the slot
+ */
+typedef struct channel_cell_s
+{
+	size_t seq;
+	int value;
+} channel_cell_t;
+
+/**
+ * struct channel_s - named bounded queue shared between interpreters
+ * @name: channel name
+ * @mask: capacity - 1, the capacity being a power of two
+ * @cells: ring buffer
+ * @next: next channel in the registry
+ * @wait_lock: protects parking on the channel
+ * @wait_cond: signalled when a send or recv on the channel succeeds
+ * @parked: number of scripts parked on the channel
+ * @pad0: keeps the read-only fields off the producers' cache line
+ * @enqueue_pos: next position to write, shared by producers
+ * @pad1: keeps producers and consumers on separate cache lines
+ * @dequeue_pos: next position to read, shared by consumers
+ *
+ * Description: a lock-free multi-producer multi-consumer queue of ints.
+ * A slot whose sequence number equals a position is free for the producer
+ * claiming that position; one past it, the value is ready for the
+ * consumer claiming it.
+ */
+typedef struct channel_s
+{
+	char *name;
+	size_t mask;
+	channel_cell_t *cells;
+	struct channel_s *next;
+	pthread_mutex_t wait_lock;
+	pthread_cond_t wait_cond;
+	unsigned int parked;
+	char pad0[CACHE_LINE];
+	size_t enqueue_pos;
+	char pad1[CACHE_LINE - sizeof(size_t)];
+	size_t dequeue_pos;
+} channel_t;
+
+/**
+ * struct insn_s - decoded instruction
+ * @op: opcode
+ * @arg: integer argument for push, number of values for inline data
+ * @line_num: line number in the script
+ * @text: opcode text, kept for unknown instruction errors, or the path of
+ * an external data file
+ * @data: values of an inline data directive, or NULL
+ * @channel: channel used by send and recv, or NULL
+ * @block: translated block starting at this instruction, or NULL
+ */
+typedef struct insn_s
+{
+	opcode_t op;
+	int arg;
+	unsigned int line_num;
+	char *text;
+	int32_t *data;
+	channel_t *channel;
+	ir_block_t *block;
+} insn_t;
+
 /**
  * struct monty_program_s -structure for Monty program's information
  * @stack: pointer to the top of the stack
  * @line_num: current line number in the script
+ * @lines_read: number of lines read from the script so far
  * @script_file: file pointer to the Monty bytecode file
+ * @line_buf: buffer holding the line being decoded, grown by getline
+ * @line_size: size of @line_buf
  * @current_line: current line from the file
  * @current_opcode: current opcode being executed
  * @current_arg: current argument for the opcode, if applicable
+ * @current_insn: decoded instruction being executed
  * @mode: Mode of operation (MODE_STACK or MODE_QUEUE)
+ * @tail: last node of the queue, while consecutive quickened queue pushes,
+ * data directives and recvs run, NULL otherwise
+ * @quick_hits: quickened instructions that ran as specialised
+ * @code: decoded instructions of the script
+ * @code_len: number of decoded instructions
+ * @blocks: translated blocks of the chunk
+ * @n_blocks: number of translated blocks
+ * @open_block: block the next decoded instruction may extend, or NULL
+ * @ir_code: IR instructions of the blocks, one block after the other
+ * @ir_out: output registers of the blocks, one block after the other
+ * @regs: register file shared by the blocks, indexed from -2 *
+ * PROGRAM_CHUNK to PROGRAM_CHUNK - 1
  *
  * Description: holds all the necessary information to manage a Monty
  * bytecode script, including the state of the stack, the current
@@ -69,22 +300,75 @@ typedef struct monty_program_s
 {
 	stack_t *stack;
 	unsigned int line_num;
+	unsigned int lines_read;
 	FILE *script_file;
+	char *line_buf;
+	size_t line_size;
 	char *current_line;
 	char *current_opcode;
 	int current_arg;
+	insn_t *current_insn;
 	stack_mode_t mode;
+	stack_t *tail;
+	unsigned long quick_hits;
+	insn_t *code;
+	unsigned int code_len;
+	ir_block_t *blocks;
+	unsigned int n_blocks;
+	ir_block_t *open_block;
+	ir_insn_t *ir_code;
+	int *ir_out;
+	int *regs;
 } monty_program_t;
 
 extern monty_program_t program;
 extern monty_program_t *program_ptr;
 extern char **environ;
+extern size_t channel_capacity;
+extern int channel_blocking;
+extern unsigned int live_contexts;
 
 /* core.c */
-void parse_line(monty_program_t *program_ptr);
-void execute_opcode(monty_program_t *program_ptr);
+void parse_line(monty_program_t *program_ptr, insn_t *insn);
+opcode_t lookup_opcode(const char *opcode);
+void execute_opcode(monty_program_t *program_ptr, insn_t *insn);
 void free_stack(stack_t *stack);
 
+/* program.c */
+unsigned int load_program(monty_program_t *program_ptr);
+void run_program(monty_program_t *program_ptr);
+void free_program(monty_program_t *program_ptr);
+void *run_script(void *arg);
+
+/* translate.c */
+void translate_insn(monty_program_t *program_ptr, insn_t *insn,
+	stack_mode_t mode);
+
+/* quicken.c */
+void quicken_program(monty_program_t *program_ptr);
+stack_t *queue_tail(monty_program_t *program_ptr);
+void push_queue_opcode(monty_program_t *program_ptr);
+void print_quicken_stats(monty_program_t *program_ptr);
+
+/* regvm.c */
+int run_block(monty_program_t *program_ptr, ir_block_t *block);
+
+/* data.c */
+void parse_data(insn_t *insn, char **saveptr);
+void push_values(monty_program_t *program_ptr, const int32_t *values,
+	size_t count);
+void data_opcode(monty_program_t *program_ptr);
+
+/* channel.c */
+void parse_channel(insn_t *insn, char **saveptr);
+int channel_push(channel_t *channel, int value);
+int channel_pop(channel_t *channel, int *value);
+void free_channels(void);
+
+/* wait.c */
+void channel_progress(channel_t *channel);
+int channel_transfer(channel_t *channel, int send, int *value);
+
 /* 1-opcodes.c */
 void push_opcode(monty_program_t *program_ptr);
 void pall_opcode(monty_program_t *program_ptr);
@@ -109,5 +393,13 @@ void rotr_opcode(monty_program_t *program_ptr);
 /* 4-opcodes.c */
 void stack_opcode(monty_program_t *program_ptr);
 void queue_opcode(monty_program_t *program_ptr);
+void bad_push_opcode(monty_program_t *program_ptr);
+void bad_data_opcode(monty_program_t *program_ptr);
+void unknown_opcode(monty_program_t *program_ptr);
+
+/* 5-opcodes.c */
+void send_opcode(monty_program_t *program_ptr);
+void recv_opcode(monty_program_t *program_ptr);
+void bad_channel_opcode(monty_program_t *program_ptr);
 
 #endif /* MONTY_H */
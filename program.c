@@ -0,0 +1,175 @@
+#include "monty.h"
+
+/**
+ * alloc_chunk - allocates the arrays a chunk is decoded into
+ * @program_ptr: pointer to the monty_program_t struct
+ *
+ * Description: the instructions, the blocks, their IR, their out lists
+ * and the register file share one allocation. A chunk holds at most
+ * PROGRAM_CHUNK instructions; two blocks are always separated by an
+ * instruction outside both; each instruction emits at most one IR
+ * instruction and adds at most two registers to a block's inputs or to
+ * its out list.
+ */
+static void alloc_chunk(monty_program_t *program_ptr)
+{
+	program_ptr->code = malloc(sizeof(insn_t) * PROGRAM_CHUNK +
+		sizeof(ir_block_t) * (PROGRAM_CHUNK / 2 + 1) +
+		sizeof(ir_insn_t) * PROGRAM_CHUNK + sizeof(int) * 5 * PROGRAM_CHUNK);
+	if (program_ptr->code == NULL)
+	{
+		fprintf(stderr, "Error: malloc failed\n");
+		exit(EXIT_FAILURE);
+	}
+	program_ptr->blocks = (ir_block_t *)(program_ptr->code + PROGRAM_CHUNK);
+	program_ptr->ir_code = (ir_insn_t *)(program_ptr->blocks +
+		PROGRAM_CHUNK / 2 + 1);
+	program_ptr->ir_out = (int *)(program_ptr->ir_code + PROGRAM_CHUNK);
+	program_ptr->regs = program_ptr->ir_out + 4 * PROGRAM_CHUNK;
+}
+
+/**
+ * load_program - decodes the next chunk of the script
+ * @program_ptr: pointer to the monty_program_t struct
+ *
+ * Description: this function reads up to PROGRAM_CHUNK lines, decodes
+ * each of them with parse_line and translates it with translate_insn in
+ * the same pass. Lines are read whole, whatever their length, so an
+ * inline data blob is never split. Empty lines and comments do not
+ * produce instructions. Decoding a bounded chunk at a time keeps the
+ * instructions and their translated blocks small enough to stay in cache,
+ * whatever the size of the script. The chunk's arrays are reused from one
+ * chunk to the next and freed once the end of the script is reached.
+ *
+ * Return: number of instructions decoded, 0 at the end of the script
+ */
+unsigned int load_program(monty_program_t *program_ptr)
+{
+	unsigned int lines = 0;
+	stack_mode_t mode = program_ptr->mode;
+	insn_t *insn;
+
+	if (program_ptr->code == NULL)
+		alloc_chunk(program_ptr);
+	program_ptr->code_len = 0;
+	program_ptr->n_blocks = 0;
+	program_ptr->open_block = NULL;
+	while (lines < PROGRAM_CHUNK &&
+		getline(&program_ptr->line_buf, &program_ptr->line_size,
+			program_ptr->script_file) != -1)
+	{
+		lines++;
+		program_ptr->line_num = ++program_ptr->lines_read;
+		program_ptr->current_line = program_ptr->line_buf;
+		insn = &program_ptr->code[program_ptr->code_len];
+		parse_line(program_ptr, insn);
+		if (program_ptr->current_opcode == NULL)
+			continue;
+		if (insn->op == OP_STACK)
+			mode = MODE_STACK;
+		else if (insn->op == OP_QUEUE)
+			mode = MODE_QUEUE;
+		translate_insn(program_ptr, insn, mode);
+		program_ptr->code_len++;
+	}
+	program_ptr->current_line = NULL;
+	program_ptr->current_opcode = NULL;
+	if (lines == 0)
+	{
+		free(program_ptr->code);
+		program_ptr->code = NULL;
+	}
+	return (lines);
+}
+
+/**
+ * run_program - executes the decoded instructions
+ * @program_ptr: pointer to the monty_program_t struct
+ *
+ * Description: this function walks the instruction array in order. When
+ * an instruction starts a translated block and the stack is deep enough
+ * for it, the whole block runs on the register machine. Otherwise the
+ * instruction runs through its opcode handler. The cached queue tail only
+ * survives across quickened queue pushes, data directives and recvs,
+ * which keep it up to date, so it is cleared before any other instruction
+ * runs. Nothing touches the stack between two chunks, so such a run keeps
+ * its tail across them.
+ */
+void run_program(monty_program_t *program_ptr)
+{
+	unsigned int i = 0;
+	insn_t *insn;
+
+	while (i < program_ptr->code_len)
+	{
+		insn = &program_ptr->code[i];
+		if (insn->op != OP_PUSH_QUEUE && insn->op != OP_DATA &&
+			insn->op != OP_RECV)
+			program_ptr->tail = NULL;
+		if (insn->block != NULL && run_block(program_ptr, insn->block))
+		{
+			program_ptr->quick_hits += insn->block->n_quick;
+			i += insn->block->len;
+		}
+		else
+		{
+			execute_opcode(program_ptr, insn);
+			i++;
+		}
+	}
+}
+
+/**
+ * free_program - frees the decoded instructions
+ * @program_ptr: pointer to the monty_program_t struct
+ *
+ * Description: this function frees every saved opcode text and every
+ * inline data block of the current chunk, leaving the instruction array
+ * empty for the next one. Translated blocks live in the chunk's arrays
+ * and need no freeing. The cached queue tail is left alone: run_program
+ * clears it before any instruction that could make it stale.
+ */
+void free_program(monty_program_t *program_ptr)
+{
+	unsigned int i;
+	insn_t *insn;
+
+	for (i = 0; i < program_ptr->code_len; i++)
+	{
+		insn = &program_ptr->code[i];
+		free(insn->text);
+		free(insn->data);
+	}
+	program_ptr->code_len = 0;
+}
+
+/**
+ * run_script - loads and runs a whole script
+ * @arg: pointer to the monty_program_t struct of an opened script
+ *
+ * Description: this function decodes, translates, quickens and runs the
+ * script one chunk at a time, then closes it and frees its stack. It is
+ * the entry point of every interpreter thread in pipeline mode. When it
+ * returns, scripts blocked on a channel stop counting on this one.
+ *
+ * Return: NULL
+ */
+void *run_script(void *arg)
+{
+	monty_program_t *program_ptr = arg;
+
+	while (load_program(program_ptr))
+	{
+		quicken_program(program_ptr);
+		run_program(program_ptr);
+		free_program(program_ptr);
+	}
+	fclose(program_ptr->script_file);
+	free(program_ptr->line_buf);
+	program_ptr->line_buf = NULL;
+	free_stack(program_ptr->stack);
+	program_ptr->stack = NULL;
+	print_quicken_stats(program_ptr);
+	__atomic_sub_fetch(&live_contexts, 1, __ATOMIC_RELEASE);
+	return (NULL);
+}
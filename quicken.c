@@ -0,0 +1,99 @@
+#include "monty.h"
+
+/**
+ * quicken_program - rewrites instructions into specialised variants
+ * @program_ptr: pointer to the monty_program_t struct
+ *
+ * Description: Monty has no jumps, so every instruction of a chunk runs
+ * at most once and the mode it will run in is already known from the
+ * mode the chunk starts in and the stack/queue opcodes before it. Each
+ * push that will run in queue mode is rewritten in place, before it runs,
+ * into push_queue. The mode is exact, so the specialised push never has to
+ * fall back to the generic one. Pushes in stack mode are left alone: they
+ * run as register IR, and only reach a handler when a block falls back on
+ * a stack too short for it.
+ */
+void quicken_program(monty_program_t *program_ptr)
+{
+	stack_mode_t mode = program_ptr->mode;
+	insn_t *insn, *end = program_ptr->code + program_ptr->code_len;
+
+	for (insn = program_ptr->code; insn < end; insn++)
+	{
+		if (insn->op == OP_STACK)
+			mode = MODE_STACK;
+		else if (insn->op == OP_QUEUE)
+			mode = MODE_QUEUE;
+		else if (insn->op == OP_PUSH && mode == MODE_QUEUE)
+			insn->op = OP_PUSH_QUEUE;
+	}
+}
+
+/**
+ * queue_tail - finds the last node of the queue
+ * @program_ptr: pointer to the monty_program_t struct
+ *
+ * Description: this function returns the cached tail when there is one
+ * and walks the queue otherwise.
+ *
+ * Return: the last node, or NULL if the queue is empty
+ */
+stack_t *queue_tail(monty_program_t *program_ptr)
+{
+	stack_t *tail = program_ptr->tail;
+
+	if (tail == NULL && program_ptr->stack != NULL)
+	{
+		for (tail = program_ptr->stack; tail->next != NULL;
+			tail = tail->next)
+			;
+	}
+	return (tail);
+}
+
+/**
+ * push_queue_opcode - push specialised for queue mode
+ * @program_ptr: pointer to the monty_program_t struct
+ *
+ * Description: this function adds a new node at the end of the queue. The
+ * node it adds is remembered as the tail, so a run of queue pushes walks
+ * the queue once instead of once per push. run_program forgets the tail
+ * as soon as an instruction that doesn't maintain it runs.
+ */
+void push_queue_opcode(monty_program_t *program_ptr)
+{
+	stack_t *new_node, *tail = queue_tail(program_ptr);
+
+	program_ptr->quick_hits++;
+	new_node = malloc(sizeof(stack_t));
+	if (new_node == NULL)
+	{
+		fprintf(stderr, "Error: malloc failed\n");
+		exit(EXIT_FAILURE);
+	}
+	new_node->n = program_ptr->current_arg;
+	new_node->next = NULL;
+	new_node->prev = tail;
+	if (tail == NULL)
+		program_ptr->stack = new_node;
+	else
+		tail->next = new_node;
+	program_ptr->tail = new_node;
+}
+
+/**
+ * print_quicken_stats - reports how often quickened instructions hit
+ * @program_ptr: pointer to the monty_program_t struct
+ *
+ * Description: when the MONTY_QUICKEN_STATS environment variable is set,
+ * this function prints the number of specialised instructions that ran
+ * (quickened pushes and register IR on an immediate divisor). Both are
+ * specialised on facts known before the chunk runs, so none of them can
+ * miss.
+ */
+void print_quicken_stats(monty_program_t *program_ptr)
+{
+	if (getenv("MONTY_QUICKEN_STATS") == NULL)
+		return;
+	fprintf(stderr, "quicken: %lu hits\n", program_ptr->quick_hits);
+}
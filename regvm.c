@@ -0,0 +1,151 @@
+#include "monty.h"
+
+/**
+ * load_inputs - copies the elements a block reads into its registers
+ * @stack: top of the stack
+ * @block: block about to run
+ * @r: register file
+ *
+ * Return: 1 on success, 0 if the stack is too short for the block
+ */
+static int load_inputs(stack_t *stack, ir_block_t *block, int *r)
+{
+	int i;
+
+	for (i = 0; i < block->n_in; i++)
+	{
+		if (stack == NULL)
+			return (0);
+		r[-1 - i] = stack->n;
+		stack = stack->next;
+	}
+	return (1);
+}
+
+/**
+ * store_outputs - materialises the outputs of a block on the stack
+ * @program_ptr: pointer to the monty_program_t struct
+ * @block: block that just ran
+ * @r: register file
+ *
+ * Description: nodes that stay on the stack are reused as they are, so a
+ * block only allocates or frees the difference between what it reads and
+ * what it leaves behind. A reused node whose output register still holds
+ * the input read from it is not written back; new nodes are filled as
+ * they are allocated.
+ */
+static void store_outputs(monty_program_t *program_ptr, ir_block_t *block,
+	int *r)
+{
+	stack_t *node;
+	int i, kept, dropped = block->n_in - block->n_out;
+
+	kept = dropped > 0 ? block->n_out : block->n_in;
+	for (; dropped > 0; dropped--)
+	{
+		node = program_ptr->stack;
+		program_ptr->stack = node->next;
+		free(node);
+	}
+	dropped = block->n_in - kept;
+	node = program_ptr->stack;
+	for (i = kept - 1; i >= 0; i--)
+	{
+		if (block->out[i] != -1 - (kept - 1 - i + dropped))
+			node->n = r[block->out[i]];
+		node = node->next;
+	}
+	for (i = kept; i < block->n_out; i++)
+	{
+		node = malloc(sizeof(stack_t));
+		if (node == NULL)
+		{
+			fprintf(stderr, "Error: malloc failed\n");
+			exit(EXIT_FAILURE);
+		}
+		node->n = r[block->out[i]];
+		node->next = program_ptr->stack;
+		if (program_ptr->stack != NULL)
+			program_ptr->stack->prev = node;
+		program_ptr->stack = node;
+	}
+	if (program_ptr->stack != NULL)
+		program_ptr->stack->prev = NULL;
+}
+
+/**
+ * run_ir - executes the IR instructions of a block
+ * @block: block to run
+ * @r: register file
+ *
+ * Description: division and modulo check their divisor and exit with the
+ * same message as the div and mod opcodes, unless the divisor is an
+ * immediate known not to be zero. Nothing observable happened since the
+ * block started, so the stack does not need to be materialised before
+ * exiting.
+ */
+static void run_ir(ir_block_t *block, int *r)
+{
+	ir_insn_t *ir = block->code;
+	int i;
+
+	for (i = 0; i < block->n_code; i++, ir++)
+	{
+		switch (ir->op)
+		{
+		case IR_CONST:
+			r[i] = ir->a;
+			break;
+		case IR_ADD:
+			r[i] = r[ir->a] + r[ir->b];
+			break;
+		case IR_SUB:
+			r[i] = r[ir->a] - r[ir->b];
+			break;
+		case IR_MUL:
+			r[i] = r[ir->a] * r[ir->b];
+			break;
+		case IR_DIVI:
+			r[i] = r[ir->a] / ir->b;
+			break;
+		case IR_MODI:
+			r[i] = r[ir->a] % ir->b;
+			break;
+		default:
+			if (r[ir->b] == 0)
+			{
+				fprintf(stderr, "L%d: division by zero\n",
+					ir->line_num);
+				exit(EXIT_FAILURE);
+			}
+			if (ir->op == IR_DIV)
+				r[i] = r[ir->a] / r[ir->b];
+			else
+				r[i] = r[ir->a] % r[ir->b];
+		}
+	}
+}
+
+/**
+ * run_block - runs a translated block on the register machine
+ * @program_ptr: pointer to the monty_program_t struct
+ * @block: block to run
+ *
+ * Description: the block's inputs are read into registers, its IR runs
+ * without touching the stack, and the stack is materialised once at the
+ * end by store_outputs. If the stack is too short the block does not
+ * run, so the caller can execute its instructions one by one and report
+ * the error on the right line.
+ *
+ * Return: 1 if the block ran, 0 otherwise
+ */
+int run_block(monty_program_t *program_ptr, ir_block_t *block)
+{
+	int *r = program_ptr->regs;
+
+	if (!load_inputs(program_ptr->stack, block, r))
+		return (0);
+	run_ir(block, r);
+	store_outputs(program_ptr, block, r);
+	return (1);
+}
@@ -0,0 +1,143 @@
+#include "monty.h"
+
+/**
+ * translatable - tells whether an opcode can be part of a register block
+ * @op: opcode
+ *
+ * Return: 1 for push, pop, swap, nop and the arithmetic opcodes, 0
+ * otherwise
+ */
+static int translatable(opcode_t op)
+{
+	switch (op)
+	{
+	case OP_PUSH:
+	case OP_POP:
+	case OP_SWAP:
+	case OP_ADD:
+	case OP_SUB:
+	case OP_MUL:
+	case OP_DIV:
+	case OP_MOD:
+	case OP_NOP:
+		return (1);
+	default:
+		return (0);
+	}
+}
+
+/**
+ * sym_pop - takes the top register off the symbolic stack of a block
+ * @block: block being built
+ *
+ * Description: the symbolic stack is the block's out list. Below its
+ * bottom lies the stack the block starts on, so popping past it makes
+ * the block read one more element of that stack.
+ *
+ * Return: the register popped
+ */
+static int sym_pop(ir_block_t *block)
+{
+	if (block->n_out > 0)
+		return (block->out[--block->n_out]);
+	return (-1 - block->n_in++);
+}
+
+/**
+ * emit_insn - translates one decoded instruction into register IR
+ * @block: block being built
+ * @insn: decoded instruction
+ *
+ * Description: pop and swap only rearrange the symbolic stack and nop
+ * does nothing, so none of them emit code. push and the arithmetic
+ * opcodes emit an instruction and leave its register on the symbolic
+ * stack. A div or mod whose divisor was pushed by the previous IR
+ * instruction as a nonzero constant is folded into that instruction as
+ * IR_DIVI or IR_MODI, which never checks for zero.
+ */
+static void emit_insn(ir_block_t *block, insn_t *insn)
+{
+	ir_insn_t *ir = block->n_code ? &block->code[block->n_code - 1] : NULL;
+	int a, b;
+
+	if (insn->op == OP_NOP)
+		return;
+	if (insn->op == OP_POP || insn->op == OP_SWAP)
+	{
+		a = sym_pop(block);
+		if (insn->op == OP_SWAP)
+		{
+			b = sym_pop(block);
+			block->out[block->n_out++] = a;
+			block->out[block->n_out++] = b;
+		}
+		return;
+	}
+	b = insn->op == OP_PUSH ? 0 : sym_pop(block);
+	a = insn->op == OP_PUSH ? insn->arg : sym_pop(block);
+	if ((insn->op == OP_DIV || insn->op == OP_MOD) && ir != NULL &&
+		ir->op == IR_CONST && b == block->n_code - 1 && ir->a != 0)
+	{
+		ir->op = insn->op == OP_DIV ? IR_DIVI : IR_MODI;
+		ir->b = ir->a;
+		block->n_quick++;
+	}
+	else
+	{
+		ir = &block->code[block->n_code++];
+		ir->op = insn->op == OP_PUSH ? IR_CONST :
+			insn->op == OP_ADD ? IR_ADD :
+			insn->op == OP_SUB ? IR_SUB :
+			insn->op == OP_MUL ? IR_MUL :
+			insn->op == OP_DIV ? IR_DIV : IR_MOD;
+		ir->b = b;
+	}
+	ir->a = a;
+	ir->line_num = insn->line_num;
+	block->out[block->n_out++] = ir - block->code;
+}
+
+/**
+ * translate_insn - adds a decoded instruction to the register blocks
+ * @program_ptr: pointer to the monty_program_t struct
+ * @insn: instruction just decoded
+ * @mode: mode the instruction will run in
+ *
+ * Description: Monty has no jumps, so the mode each instruction of the
+ * chunk runs in is known while it is decoded, and translation happens in
+ * the same pass. Every maximal run of translatable opcodes that runs in
+ * stack mode becomes a block attached to its first instruction. A block's
+ * IR and out list are built at the end of the chunk's IR arrays, right
+ * after the previous block's, so no block needs an allocation of its
+ * own. Opcodes that observe the whole stack (pall, pint, pchar, pstr,
+ * rotl, rotr), mode switches and error opcodes end a block and keep
+ * running through their handlers on the materialised stack.
+ */
+void translate_insn(monty_program_t *program_ptr, insn_t *insn,
+	stack_mode_t mode)
+{
+	ir_block_t *block = program_ptr->open_block, *prev;
+
+	if (mode != MODE_STACK || !translatable(insn->op))
+	{
+		program_ptr->open_block = NULL;
+		return;
+	}
+	if (block == NULL)
+	{
+		block = &program_ptr->blocks[program_ptr->n_blocks++];
+		prev = block == program_ptr->blocks ? NULL : block - 1;
+		block->code = prev ? prev->code + prev->n_code :
+			program_ptr->ir_code;
+		block->out = prev ? prev->out + prev->n_out : program_ptr->ir_out;
+		block->len = 0;
+		block->n_in = 0;
+		block->n_code = 0;
+		block->n_out = 0;
+		block->n_quick = 0;
+		insn->block = block;
+		program_ptr->open_block = block;
+	}
+	block->len++;
+	emit_insn(block, insn);
+}
@@ -0,0 +1,140 @@
+#include "monty.h"
+
+static unsigned int waiting;
+static uint64_t wait_state;
+
+/**
+ * channel_progress - records that a channel operation succeeded
+ * @channel: channel the operation succeeded on
+ *
+ * Description: wait_state holds a progress epoch in its upper 32 bits
+ * and, in its lower 32 bits, the number of waiting scripts that failed an
+ * attempt started in that epoch. While any script waits, every successful
+ * send or recv starts a new epoch, which resets that number, and wakes
+ * the scripts parked on the channel. The fence pairs with the ones in
+ * channel_transfer and park: either this function sees the waiter, or the
+ * waiter's next attempt sees this operation.
+ */
+void channel_progress(channel_t *channel)
+{
+	uint64_t state;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&waiting, __ATOMIC_RELAXED) == 0)
+		return;
+	state = __atomic_load_n(&wait_state, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&wait_state, &state,
+		((state >> 32) + 1) << 32, 1, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+		;
+	if (__atomic_load_n(&channel->parked, __ATOMIC_SEQ_CST) == 0)
+		return;
+	pthread_mutex_lock(&channel->wait_lock);
+	pthread_cond_broadcast(&channel->wait_cond);
+	pthread_mutex_unlock(&channel->wait_lock);
+}
+
+/**
+ * stuck - counts a failed attempt and checks for a deadlock
+ * @seen: wait_state read before the attempt
+ * @settled: epoch + 1 in which the caller was already counted, or 0
+ *
+ * Description: a waiting script is counted once per epoch. When every
+ * live script is counted in the current epoch, all of them are waiting
+ * and none of them can succeed, since nothing succeeded since their last
+ * attempt began.
+ *
+ * Return: 1 if no waiting script can ever succeed, 0 otherwise
+ */
+static int stuck(uint64_t seen, uint64_t *settled)
+{
+	uint64_t epoch = seen >> 32, state = seen;
+
+	if (*settled != epoch + 1)
+	{
+		while ((state >> 32) == epoch &&
+			!__atomic_compare_exchange_n(&wait_state, &state, state + 1,
+			1, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+			;
+		if ((state >> 32) != epoch)
+			return (0);
+		*settled = epoch + 1;
+	}
+	state = __atomic_load_n(&wait_state, __ATOMIC_SEQ_CST);
+	return ((state >> 32) == epoch && (state & 0xffffffff) >=
+		__atomic_load_n(&live_contexts, __ATOMIC_SEQ_CST));
+}
+
+/**
+ * park - sleeps until the channel makes progress
+ * @channel: channel
+ * @seen: wait_state read before the last failed attempt
+ *
+ * Description: the caller sleeps only if no send or recv succeeded since
+ * its last attempt; channel_progress takes the lock before waking it, so
+ * the wake-up can't be lost. The sleep is bounded by WAIT_PARK_NS so a
+ * script parked here still counts itself in epochs started by progress on
+ * other channels, which keeps the deadlock check going.
+ */
+static void park(channel_t *channel, uint64_t seen)
+{
+	struct timespec deadline;
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_nsec += WAIT_PARK_NS;
+	if (deadline.tv_nsec >= 1000000000L)
+	{
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+	pthread_mutex_lock(&channel->wait_lock);
+	__atomic_add_fetch(&channel->parked, 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&wait_state, __ATOMIC_SEQ_CST) >> 32 == seen >> 32)
+		pthread_cond_timedwait(&channel->wait_cond, &channel->wait_lock,
+			&deadline);
+	__atomic_sub_fetch(&channel->parked, 1, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&channel->wait_lock);
+}
+
+/**
+ * channel_transfer - sends or receives a value, waiting if needed
+ * @channel: channel
+ * @send: 1 to send *value, 0 to receive into *value
+ * @value: value to send, or set to the value received
+ *
+ * Description: when the channel is full (send) or empty (recv) and
+ * channels block, this function gives up the CPU and tries again, up to
+ * WAIT_SPINS times, then parks on the channel between attempts. It
+ * returns once it succeeds or every live script is waiting with no
+ * progress possible.
+ *
+ * Return: 1 on success, 0 if the operation can't complete
+ */
+int channel_transfer(channel_t *channel, int send, int *value)
+{
+	uint64_t seen, settled = 0;
+	unsigned int spins = 0;
+	int done;
+
+	if (send ? channel_push(channel, *value) : channel_pop(channel, value))
+		return (1);
+	if (!channel_blocking)
+		return (0);
+	__atomic_add_fetch(&waiting, 1, __ATOMIC_SEQ_CST);
+	for (;;)
+	{
+		seen = __atomic_load_n(&wait_state, __ATOMIC_SEQ_CST);
+		done = send ? channel_push(channel, *value) :
+			channel_pop(channel, value);
+		if (done || stuck(seen, &settled))
+			break;
+		if (spins < WAIT_SPINS)
+		{
+			spins++;
+			sched_yield();
+		}
+		else
+			park(channel, seen);
+	}
+	__atomic_sub_fetch(&waiting, 1, __ATOMIC_SEQ_CST);
+	return (done);
+}